@@ -1,14 +1,76 @@
 #ifdef _WIN32
 #include <Windows.h>
+#else
+#include <sys/wait.h>
+#include <unistd.h>
+#include <signal.h>
 #endif // _WIN32
 
 #include <iostream>
 #include <fstream>
 #include <array>
+#include <string>
+#include <ctime>
+#include <chrono>
+#include <stdexcept>
 
 #include "fonctions.h"
+#include "regression.h"
+#include "journal.h"
+#include "memoire.h"
 
-int main()
+/**
+ * Affiche l'aide des options du programme puis le termine.
+ */
+static void usage()
+{
+    std::cerr << "Usage : SolutionSAE2 [options]\n"
+              << "  --lignes L                 nombre de tailles N tirees (10 par defaut)\n"
+              << "  --repetitions R            nombre de mesures par case, au plus 65535 (1 par defaut)\n"
+              << "  --graine G                 graine des tirages aleatoires (l'heure par defaut)\n"
+              << "  --journal F                journal binaire des resultats (tri.bin par defaut)\n"
+              << "  --reprendre                reprend le journal apres la derniere case terminee\n"
+              << "  --synchro S                secondes entre deux ecritures forcees du journal sur le disque (10 par defaut)\n"
+              << "  --exporter                 n'execute aucun tri, exporte seulement le journal vers tri.csv et memoire.csv\n"
+              << "  --shard I/N                n'execute que le shard I (de 0 a N-1) de la campagne, exige --graine ;\n"
+              << "                             tous les shards doivent etre executes par le meme programme sur la meme plateforme\n"
+              << "  --fusion N                 n'execute aucun tri, fusionne les journaux des N shards\n"
+              << "  --local N                  execute les N shards dans N processus puis les fusionne (Linux), exige --graine\n"
+              << "                             apres --fusion ou --local, les temps sont ignores par --reference-*\n"
+              << "  --reference-ecrire F       ajuste les mesures et les enregistre comme reference dans F\n"
+              << "  --reference-verifier F     compare les mesures a la reference F, code de sortie 2 si regression,\n"
+              << "                             3 si une serie de F n'a pas pu etre comparee\n"
+              << "  --tolerance T              ralentissement accepte sur les comparaisons (0.1 = 10 % par defaut)\n"
+              << "  --tolerance-temps T        ralentissement accepte sur les temps (0.3 = 30 % par defaut) ;\n"
+              << "                             les series de moins de 10 us en moyenne ne sont pas comparees\n";
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Convertit les enregistrements d'un journal en mesures pour l'ajustement et la comparaison  la rfrence.
+ * Les enregistrements dont un indice ne correspond  aucun tri, gnration ou mtrique connu sont ignors.
+ *
+ * \param[in] cheminJournal Le chemin du journal
+ * \param[in] nbTris Le nombre de mthodes de tri
+ * \param[in] nbGenerateurs Le nombre de mthodes de gnration
+ * \param[in] avecTemps Faux pour ignorer la mtrique Temps
+ * \return les mesures
+ */
+static std::vector<Mesure> versMesures(const std::string& cheminJournal, size_t nbTris, size_t nbGenerateurs, bool avecTemps)
+{
+    LecteurJournal lecteur(cheminJournal);
+    std::vector<Mesure> mesures;
+    Enregistrement e;
+    while (lecteur.suivant(e)) {
+        if (e.algo >= nbTris || e.generateur >= nbGenerateurs || e.metrique >= NB_METRIQUES
+            || (!avecTemps && e.metrique == static_cast<uint8_t>(Metrique::Temps)))
+            continue;
+        mesures.push_back({ e.algo, e.generateur, static_cast<Metrique>(e.metrique), e.ligne, e.N, e.valeur });
+    }
+    return mesures;
+}
+
+int main(int argc, char* argv[])
 {
 #ifdef _WIN32
     SetConsoleOutputCP(CP_UTF8);
@@ -22,34 +84,231 @@ int main()
 
     std::array<std::string, 6> tab_sortie = { "N","Aleat", "PresqueTri", "PresqueTriDeb", "PresqueTriDebFin", "PresqueTriFin" };        // Ce tableau rpertorie les nom des diffrentes mthodes de gnration du tableau ainsi que N, le nombre d'lments du tableau.
 
-    std::ofstream out("tri.csv");        // On cre le fichier CSV
+    const std::vector<std::string> nomGenerateurs(tab_sortie.begin() + 1, tab_sortie.end());
+
+    int nbLignes = 10;
+    int nbRepetitions = 1;
+    unsigned int graine = static_cast<unsigned int>(std::time(0));     // Alatoire un peu plus alatoire
+    std::string cheminJournal = "tri.bin";
+    bool reprendre = false;
+    bool exporter = false;
+    bool graineDonnee = false;
+    uint16_t shard = 0;
+    uint16_t nbShards = 1;
+    int nbFusion = 0;
+    int nbProcessus = 0;
+    double intervalleSynchro = 10;
+    double tolerance = 0.1;
+    double toleranceTemps = 0.3;
+    std::string referenceEcrire, referenceVerifier;
 
-    if (!out.is_open()) {
-        std::cerr << "Impossible d'ouvir le fichier";
+    try {                                                       // Une valeur numrique invalide affiche l'aide
+        for (int a = 1; a < argc; a++) {                        // Lecture des options
+            const std::string option = argv[a];
+            if (option == "--reprendre") {
+                reprendre = true;
+                continue;
+            }
+            if (option == "--exporter") {
+                exporter = true;
+                continue;
+            }
+            if (a + 1 >= argc)
+                usage();
+            const std::string valeur = argv[++a];
+            if (option == "--lignes")
+                nbLignes = std::stoi(valeur);
+            else if (option == "--repetitions")
+                nbRepetitions = std::stoi(valeur);
+            else if (option == "--graine") {
+                graine = std::stoul(valeur);
+                graineDonnee = true;
+            }
+            else if (option == "--shard") {                     // Format I/N
+                const size_t barre = valeur.find('/');
+                if (barre == std::string::npos)
+                    usage();
+                const int i = std::stoi(valeur.substr(0, barre));
+                const int n = std::stoi(valeur.substr(barre + 1));
+                if (n < 1 || n > 65535 || i < 0 || i >= n)
+                    usage();
+                shard = static_cast<uint16_t>(i);
+                nbShards = static_cast<uint16_t>(n);
+            }
+            else if (option == "--fusion")
+                nbFusion = std::stoi(valeur);
+            else if (option == "--local")
+                nbProcessus = std::stoi(valeur);
+            else if (option == "--journal")
+                cheminJournal = valeur;
+            else if (option == "--synchro")
+                intervalleSynchro = std::stod(valeur);
+            else if (option == "--reference-ecrire")
+                referenceEcrire = valeur;
+            else if (option == "--reference-verifier")
+                referenceVerifier = valeur;
+            else if (option == "--tolerance")
+                tolerance = std::stod(valeur);
+            else if (option == "--tolerance-temps")
+                toleranceTemps = std::stod(valeur);
+            else
+                usage();
+        }
+    }
+    catch (const std::exception&) {
+        usage();
+    }
+    if (nbLignes < 1 || nbRepetitions < 1 || nbRepetitions > 65535 || nbFusion < 0 || nbFusion > 65535 || nbProcessus < 0 || nbProcessus > 65535)
+        usage();                                                // Les rptitions sont numrotes sur 16 bits dans le journal
+    if (!(intervalleSynchro >= 0) || !(tolerance >= 0) || !(toleranceTemps >= 0))
+        usage();                                                // crit ainsi pour refuser aussi nan
+    if (nbProcessus > 0 && (nbShards > 1 || nbFusion > 0)) {   // --local choisit lui-mme les shards et la fusion
+        std::cerr << "--local ne se combine ni avec --shard ni avec --fusion\n";
+        exit(EXIT_FAILURE);
+    }
+    if ((nbShards > 1 || nbProcessus > 1) && !graineDonnee) {   // Sans graine commune, les shards relancs ne tireraient pas les mmes N
+        std::cerr << "--shard et --local exigent --graine, avec la meme valeur pour tous les shards et leurs reprises\n";
+        exit(EXIT_FAILURE);
+    }
+
+    if (nbProcessus > 1) {                                      // Mode local : un processus par shard, puis fusion
+#ifdef _WIN32
+        std::cerr << "--local n'est disponible que sous Linux, utilisez --shard et --fusion\n";
         exit(EXIT_FAILURE);
+#else
+        std::cout.flush();
+        std::vector<pid_t> enfants;
+        bool enfant = false;
+        for (int p = 0; p < nbProcessus; p++) {
+            const pid_t pid = fork();
+            if (pid < 0) {                                      // Les shards dj lancs sont arrts : leurs journaux restent repris par --reprendre
+                std::cerr << "Impossible de lancer le shard " << p << ", arret des shards deja lances, relancez avec --reprendre et la meme graine\n";
+                for (pid_t lance : enfants)
+                    kill(lance, SIGTERM);
+                for (pid_t lance : enfants)
+                    waitpid(lance, nullptr, 0);
+                exit(EXIT_FAILURE);
+            }
+            if (pid == 0) {                                     // Le processus enfant excute son shard avec la graine du parent
+                enfant = true;
+                shard = static_cast<uint16_t>(p);
+                nbShards = static_cast<uint16_t>(nbProcessus);
+                break;
+            }
+            enfants.push_back(pid);
+        }
+
+        if (!enfant) {                                          // Le parent attend tous les shards puis les fusionne
+            bool echec = false;
+            for (pid_t pid : enfants) {
+                int statut = 0;
+                waitpid(pid, &statut, 0);
+                echec = echec || !WIFEXITED(statut) || WEXITSTATUS(statut) != EXIT_SUCCESS;
+            }
+            if (echec) {
+                std::cerr << "Au moins un shard a echoue, relancez avec --reprendre et la meme graine\n";
+                exit(EXIT_FAILURE);
+            }
+            nbFusion = nbProcessus;
+        }
+#endif // _WIN32
+    }
+
+    if (exporter) {                                             // Les rsultats sont relus du journal, un enregistrement  la fois
+        LecteurJournal lecteur(cheminJournal);
+        verifierBalayage(cheminJournal, lecteur.entete(), static_cast<uint16_t>(tabTrie.size()), static_cast<uint16_t>(tabFunction.size()));
+    }
+    else if (nbFusion > 0) {
+        const std::string premierShard = cheminShard(cheminJournal, 0, static_cast<uint16_t>(nbFusion));
+        verifierBalayage(premierShard, LecteurJournal(premierShard).entete(), static_cast<uint16_t>(tabTrie.size()), static_cast<uint16_t>(tabFunction.size()));
+        fusionnerShards(cheminJournal, static_cast<uint16_t>(nbFusion));     // Le journal fusionn est celui d'une campagne non dcoupe
     }
+    else {
+        EnteteJournal entete = creerEntete(graine, nbLignes, nbRepetitions, static_cast<uint16_t>(tabTrie.size()), static_cast<uint16_t>(tabFunction.size()), shard, nbShards);
+        Journal journal(nbShards > 1 ? cheminShard(cheminJournal, shard, nbShards) : cheminJournal,
+                        entete, NB_METRIQUES, reprendre, intervalleSynchro);     // En reprise, l'entte du journal remplace les options
 
-    out << "N;";                                                // On ajoute l'entte.
-    for (size_t i = 0; i < nomTrie.size(); i++)                 // Cette boucle permet d'associer les mthodes de gnration des tableaux avec leur mthode de trie. Par exemple, pour la mthode de tri Cocktail nous aurons : N | Aleat Cocktail | PresqueTri Cocktail |....
-        for (size_t j = 1; j < tab_sortie.size(); j++)
-            out << tab_sortie[j] + " " + nomTrie[i] << ";";     // Le -> ; permet de se dplacer de 1 case vers la droite dans le CSV.
-    out << "\n";                                                // Retour  la ligne dans le CSV
-    
-    std::srand(std::time(0));                                   // Alatoire un peu plus alatoire
-    for (int i = 0; i < 10; ++i) {                              // On cre 10 tableaux
-        size_t N = std::rand() % 60 + 3;                             // On gnre un N qui va tre la taille de notre.
-        while (N < 2)
-            N = std::rand() % 60 + 3;
-        out << N;                                               // On le met dans le CSV
-
-        for (const auto& triFunc : tabTrie) {                   // Pour chaque mthode de tri :
-            for (const auto& initFunc : tabFunction) {
-                std::vector<int> tab = initFunc(N);             // On gnre des tableaux avec les mthodes de gnration
-                out << ';' << triFunc(tab);                     // Puis on rentre directement le nombre de comparaison dans le CSV.
-                verifTri(tab);                                  // On vrifie si le tableau est bien tri
+        std::vector<size_t> tailles(entete.nbLignes);          // Les N sont tirs  partir de la graine pour tre les mmes  la reprise
+        std::srand(entete.graine);
+        for (auto& N : tailles)
+            N = std::rand() % 60 + 3;                           // On gnre un N qui va tre la taille de notre tableau.
+
+        size_t numeroCase = 0;                                  // Numro de la case dans toute la campagne
+        size_t casesDuShard = 0;                                // Nombre de cases de ce shard dj rencontres
+        for (uint32_t i = 0; i < entete.nbLignes; ++i) {       // On cre nbLignes tableaux (10 par dfaut)
+            const size_t N = tailles[i];
+            for (size_t t = 0; t < tabTrie.size(); t++) {       // Pour chaque mthode de tri :
+                for (size_t g = 0; g < tabFunction.size(); g++, numeroCase++) {
+                    if (!caseDuShard(numeroCase, entete.shard, entete.nbShards))
+                        continue;                               // Case d'un autre shard
+                    if (casesDuShard++ < journal.nbCasesTerminees())
+                        continue;                               // Case dj dans le journal
+                    std::srand(entete.graine + static_cast<unsigned int>(numeroCase));     // Chaque case a ses propres tirages, indpendants de l'ordre d'excution
+
+                    for (uint32_t r = 0; r < entete.nbRepetitions; r++) {
+                        std::vector<int> tab = tabFunction[g](N);   // On gnre des tableaux avec les mthodes de gnration
+                        reinitialiserMemoire();                 // La mmoire auxiliaire et la rcursion sont comptes pendant le tri
+                        const auto debut = std::chrono::steady_clock::now();
+                        const unsigned int nb_comparaison = tabTrie[t](tab);
+                        const std::chrono::duration<double, std::nano> duree = std::chrono::steady_clock::now() - debut;
+                        verifTri(tab, nomTrie[t]);              // On vrifie si le tableau est bien tri
+
+                        Enregistrement e{};
+                        e.algo = static_cast<uint16_t>(t);
+                        e.generateur = static_cast<uint16_t>(g);
+                        e.ligne = i;
+                        e.N = static_cast<uint32_t>(N);
+                        e.repetition = static_cast<uint16_t>(r);
+                        e.metrique = static_cast<uint8_t>(Metrique::Comparaisons);
+                        e.valeur = nb_comparaison;
+                        journal.ajouter(e);                     // Puis on rentre directement le nombre de comparaison dans le journal.
+                        e.metrique = static_cast<uint8_t>(Metrique::Temps);
+                        e.valeur = duree.count();
+                        journal.ajouter(e);
+                        e.metrique = static_cast<uint8_t>(Metrique::OctetsPic);
+                        e.valeur = static_cast<double>(statsMemoire.octetsPic);
+                        journal.ajouter(e);
+                        e.metrique = static_cast<uint8_t>(Metrique::NbAllocations);
+                        e.valeur = static_cast<double>(statsMemoire.nbAllocations);
+                        journal.ajouter(e);
+                        e.metrique = static_cast<uint8_t>(Metrique::ProfondeurMax);
+                        e.valeur = statsMemoire.profondeurMax;
+                        journal.ajouter(e);
+                    }
+                    journal.terminerCase();
+                }
             }
         }
-        out << '\n';                                            // On saute une ligne
+    }                                                           // Le journal est ferm, les exports le relisent
+
+    if (nbShards > 1)                                           // Un shard seul n'a qu'une partie des rsultats : le CSV et la rfrence attendent la fusion
+        return EXIT_SUCCESS;
+
+    exporterCsv("tri.csv", cheminJournal, nomTrie, nomGenerateurs);      // Le CSV garde la mise en page d'origine
+    exporterMemoireCsv("memoire.csv", cheminJournal, nomTrie, nomGenerateurs);
+    if (referenceEcrire.empty() && referenceVerifier.empty())
+        return EXIT_SUCCESS;
+
+    // Les shards ont t chronomtrs en parallle ou sur d'autres machines : leurs temps ne sont pas comparables  un balayage seul
+    if (nbFusion > 0)
+        std::cerr << "Campagne fusionnee : les temps sont ignores par la reference\n";
+    std::vector<Mesure> mesures = versMesures(cheminJournal, tabTrie.size(), tabFunction.size(), nbFusion == 0);
+    regrouperTemps(mesures);                                    // Un point par case pour les temps, comme dans la rfrence
+
+    if (!referenceEcrire.empty())                               // On enregistre la loi N^exposant de chaque srie comme rfrence
+        ecrireReference(referenceEcrire, ajusterMesures(mesures), nomTrie, nomGenerateurs);
+
+    if (!referenceVerifier.empty()) {                           // On compare les mesures  la rfrence
+        const Verdict verdict = verifierReference(lireReference(referenceVerifier, nomTrie, nomGenerateurs), mesures, nomTrie, nomGenerateurs,
+                                                  tolerance, toleranceTemps, nbFusion == 0, std::cout);
+        if (verdict == Verdict::Regression) {
+            std::cerr << "Regression de performance detectee\n";
+            return CODE_REGRESSION;
+        }
+        if (verdict == Verdict::Incomplet) {
+            std::cerr << "Reference incomplete : au moins une serie n'a pas pu etre comparee\n";
+            return CODE_INCOMPLET;
+        }
     }
 }
 
@@ -4,6 +4,7 @@
  * Définition des fonctions fournies.
  */
 #include "fonctions.h"
+#include "memoire.h"
 #include <iostream>
 #include <ctime>
 #include <algorithm>
@@ -12,6 +13,8 @@
  * Crée un tableau d'entiers dont tous les éléments sont choisis aléatoirement.
  * 
  * Un tel tableau peut par exemple être 30968 28073 31177 2882 6140 17999 13828 20039 2310 24865.
+ * Les valeurs sont bornées à [0, 32767] pour que le tri par comptage garde la même taille de tableau
+ * auxiliaire sous Windows et sous Linux (où RAND_MAX vaut 2^31 - 1).
  * 
  * \param[in] N taille du tableau
  * \return le tableau initialisé
@@ -20,7 +23,7 @@ std::vector<int> initTabAleat(size_t N)
 {
   std::vector<int> tab(N);
   for (auto& val : tab)
-    val = rand();
+    val = rand() % 32768;   // Même plage de valeurs que le RAND_MAX de MSVC, quelle que soit la plateforme
   return tab;
 }
 
@@ -197,6 +200,7 @@ unsigned int triBullesOpti(std::vector<int>& tab) {
             return nb_comparaison;
 
     }
+    return nb_comparaison;
 }
 
 /**
@@ -251,6 +255,7 @@ unsigned int triPeigne(std::vector<int>& tab) {
  * \return le nombre de comparaison qui est un unsigned int
  */
 unsigned int triRapide(std::vector<int>& tab, int premier, int dernier) {
+    GardeProfondeur garde;      // Compte la profondeur de récursion
     unsigned int nb_comparaisons = 0;
 
     if (premier < dernier) {
@@ -508,7 +513,7 @@ unsigned int triParComptage(std::vector<int>& tab) {
             borneSuperieure = tab[k];
     }
 
-    std::vector<int> comptage(borneSuperieure + 1, 0);
+    VecteurCompte comptage(borneSuperieure + 1, 0);     // Tableau auxiliaire compté dans la mémoire du tri
 
     for (int k = 0; k < tab.size(); k++)
         comptage[tab[k]]++;
@@ -538,6 +543,7 @@ unsigned int triParComptage(std::vector<int>& tab) {
  * \return le nombre de comparaison
  */
 unsigned int triFaireValoir(std::vector<int>& tab, int i, int j) {
+    GardeProfondeur garde;      // Compte la profondeur de récursion
     int nb_comparaison = 1;
     if (tab[i] > tab[j]) {
         std::swap(tab[i], tab[j]);
@@ -587,8 +593,8 @@ unsigned int triParBase(std::vector<int>& tab) {
     int maxtab_int = (maxtab != tab.end()) ? *maxtab : 0;
 
     for (int exp = 1; maxtab_int / exp > 0; exp *= 10) {
-        std::vector<int> tab_sortie(tab.size());
-        std::vector<int> count(10, 0);
+        VecteurCompte tab_sortie(tab.size());       // Tableaux auxiliaires comptés dans la mémoire du tri
+        VecteurCompte count(10, 0);
 
         for (int i = 0; i < tab.size(); i++) {
             count[(tab[i] / exp) % 10]++;
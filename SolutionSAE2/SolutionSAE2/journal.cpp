@@ -0,0 +1,455 @@
+/**
+ * \file journal.cpp
+ *
+ * Définition du journal binaire des résultats et de son export CSV.
+ *
+ * Le journal commence par une EnteteJournal puis contient des Enregistrement de taille fixe, écrits tels quels
+ * (ordre des octets de la machine). Les cases (ligne, tri, génération) sont écrites l'une après l'autre dans
+ * l'ordre du balayage, chacune avec nbRepetitions * nbMetriques enregistrements : une case est terminée
+ * dès que tous ses enregistrements sont présents, ce qui permet de reprendre une campagne interrompue.
+ *
+ * Une campagne peut être découpée en shards : la case numéro k appartient au shard k modulo nbShards.
+ * Chaque shard écrit son propre journal, éventuellement sur une autre machine, et fusionnerShards
+ * les réunit dans l'ordre du balayage.
+ *
+ * Un journal peut dépasser la mémoire disponible : il n'est jamais chargé en entier, seulement lu
+ * un enregistrement à la fois par LecteurJournal.
+ */
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS         // fopen est signalée comme dangereuse par les vérifications SDL de MSVC
+#endif // _WIN32
+
+#include "journal.h"
+#include "regression.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <filesystem>
+#include <cstddef>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif // _WIN32
+
+/**
+ * Crée l'entête d'un nouveau journal.
+ *
+ * \param[in] graine La graine des tirages aléatoires de la campagne
+ * \param[in] nbLignes Le nombre de tailles N tirées
+ * \param[in] nbRepetitions Le nombre de mesures par case
+ * \param[in] nbTris Le nombre de méthodes de tri
+ * \param[in] nbGenerateurs Le nombre de méthodes de génération de tableau
+ * \param[in] shard L'indice du shard écrit dans ce journal, de 0 à nbShards - 1
+ * \param[in] nbShards Le nombre de shards de la campagne, 1 si elle n'est pas découpée
+ * \return l'entête
+ */
+EnteteJournal creerEntete(uint32_t graine, uint32_t nbLignes, uint32_t nbRepetitions, uint16_t nbTris, uint16_t nbGenerateurs,
+                          uint16_t shard, uint16_t nbShards)
+{
+    EnteteJournal entete{};
+    std::memcpy(entete.magie, "SAEJ", 4);
+    entete.version = 3;
+    entete.graine = graine;
+    entete.nbLignes = nbLignes;
+    entete.nbRepetitions = nbRepetitions;
+    entete.nbTris = nbTris;
+    entete.nbGenerateurs = nbGenerateurs;
+    entete.shard = shard;
+    entete.nbShards = nbShards;
+    entete.nbMetriques = NB_METRIQUES;
+    return entete;
+}
+
+/**
+ * Donne le chemin du journal d'un shard : tri.bin devient tri.shard2-8.bin pour le shard 2 sur 8.
+ *
+ * \param[in] chemin Le chemin du journal complet
+ * \param[in] shard L'indice du shard
+ * \param[in] nbShards Le nombre de shards
+ * \return le chemin du journal du shard, dans le même dossier
+ */
+std::string cheminShard(const std::string& chemin, uint16_t shard, uint16_t nbShards)
+{
+    std::filesystem::path p(chemin);
+    const std::string nom = p.stem().string() + ".shard" + std::to_string(shard) + "-" + std::to_string(nbShards) + p.extension().string();
+    return (p.parent_path() / nom).string();
+}
+
+/**
+ * Indique si une case du balayage appartient à un shard. Les cases sont distribuées à tour de rôle,
+ * pour que chaque shard ait des N et des tris de tous les coûts.
+ *
+ * \param[in] numeroCase Le numéro de la case dans l'ordre du balayage
+ * \param[in] shard L'indice du shard
+ * \param[in] nbShards Le nombre de shards
+ * \return vrai si la case est à exécuter par ce shard
+ */
+bool caseDuShard(size_t numeroCase, uint16_t shard, uint16_t nbShards)
+{
+    return numeroCase % nbShards == shard;
+}
+
+/**
+ * Ouvre un journal et lit son entête. Le programme est terminé si le fichier est absent ou n'est pas un journal.
+ * Un enregistrement incomplet à la fin du fichier (programme interrompu pendant l'écriture) n'est pas compté.
+ *
+ * Les journaux des versions précédentes sont aussi lus, et leur entête est complétée : la version 1
+ * (entête de 24 octets) n'avait pas de shards, et les versions 1 et 2 n'enregistraient que 2 métriques
+ * (comparaisons et temps). L'entête rendue est toujours celle de la version courante.
+ *
+ * \param[in] chemin Le chemin du journal
+ */
+LecteurJournal::LecteurJournal(const std::string& chemin)
+    : in(chemin, std::ios::binary), lue{}, nombre(0), nbLus(0)
+{
+    if (!in.is_open()) {
+        std::cerr << "Impossible d'ouvrir le fichier " << chemin << '\n';
+        exit(EXIT_FAILURE);
+    }
+
+    const size_t tailleV1 = offsetof(EnteteJournal, shard);     // Les 24 premiers octets sont communs à toutes les versions
+    if (!in.read(reinterpret_cast<char*>(&lue), tailleV1) || std::memcmp(lue.magie, "SAEJ", 4) != 0
+        || lue.version < 1 || lue.version > 3
+        || (lue.version >= 2 && !in.read(reinterpret_cast<char*>(&lue) + tailleV1, sizeof(lue) - tailleV1))) {
+        std::cerr << chemin << " n'est pas un journal de resultats\n";
+        exit(EXIT_FAILURE);
+    }
+    const size_t tailleEntete = lue.version == 1 ? tailleV1 : sizeof(lue);
+    nombre = static_cast<size_t>((std::filesystem::file_size(chemin) - tailleEntete) / sizeof(Enregistrement));
+
+    if (lue.version == 1) {
+        lue.shard = 0;
+        lue.nbShards = 1;
+    }
+    if (lue.version <= 2)
+        lue.nbMetriques = 2;                                     // Comparaisons et Temps
+    lue.version = 3;
+}
+
+/**
+ * Lit l'enregistrement suivant du journal.
+ *
+ * \param[out] enregistrement L'enregistrement lu
+ * \return faux s'il ne reste aucun enregistrement complet
+ */
+bool LecteurJournal::suivant(Enregistrement& enregistrement)
+{
+    if (nbLus == nombre || !in.read(reinterpret_cast<char*>(&enregistrement), sizeof(enregistrement)))
+        return false;
+    nbLus++;
+    return true;
+}
+
+/**
+ * Vérifie qu'un journal a été écrit avec les mêmes tris et générations que ce programme, sans quoi ses indices
+ * ne correspondent pas aux noms connus, et que ses numéros de répétition tiennent sur 16 bits (les versions
+ * précédentes acceptaient plus de répétitions et les renumérotaient à partir de 0). Le programme est terminé sinon.
+ *
+ * \param[in] chemin Le chemin du journal, pour le message d'erreur
+ * \param[in] entete L'entête lue
+ * \param[in] nbTris Le nombre de méthodes de tri de ce programme
+ * \param[in] nbGenerateurs Le nombre de méthodes de génération de ce programme
+ */
+void verifierBalayage(const std::string& chemin, const EnteteJournal& entete, uint16_t nbTris, uint16_t nbGenerateurs)
+{
+    if (entete.nbTris != nbTris || entete.nbGenerateurs != nbGenerateurs) {
+        std::cerr << "Le journal " << chemin << " a ete ecrit avec d'autres tris ou generations\n";
+        exit(EXIT_FAILURE);
+    }
+    if (entete.nbRepetitions > UINT16_MAX) {
+        std::cerr << "Le journal " << chemin << " a plus de " << UINT16_MAX << " repetitions par case : leurs numeros ont deborde\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Réunit les journaux des shards 0 à nbShards - 1 d'une campagne dans le journal complet. Le programme est terminé
+ * si un journal manque, n'appartient pas à la même campagne ou n'est pas terminé : il faut alors relancer ce shard.
+ *
+ * Chaque shard a écrit ses cases dans l'ordre du balayage, et la case numéro k appartient au shard k modulo nbShards :
+ * les journaux sont donc lus en parallèle, une case à tour de rôle, sans être chargés en mémoire.
+ *
+ * Les N sont tirés avec rand(), dont la suite dépend de la bibliothèque C : deux shards exécutés sur des
+ * plateformes différentes ont la même entête mais pas les mêmes tableaux. On vérifie donc que tous les
+ * enregistrements d'une même ligne ont le même N.
+ *
+ * \param[in] chemin Le chemin du journal complet, d'où sont déduits les chemins des shards
+ * \param[in] nbShards Le nombre de shards
+ */
+void fusionnerShards(const std::string& chemin, uint16_t nbShards)
+{
+    std::vector<LecteurJournal> lecteurs;
+    lecteurs.reserve(nbShards);
+    bool incomplet = false;
+
+    for (uint16_t shard = 0; shard < nbShards; shard++) {
+        const std::string cheminDuShard = cheminShard(chemin, shard, nbShards);
+        lecteurs.emplace_back(cheminDuShard);
+        const EnteteJournal& lue = lecteurs.back().entete();
+        const EnteteJournal& premiere = lecteurs.front().entete();
+
+        if (lue.shard != shard || lue.nbShards != nbShards || lue.graine != premiere.graine || lue.nbLignes != premiere.nbLignes
+            || lue.nbRepetitions != premiere.nbRepetitions || lue.nbTris != premiere.nbTris || lue.nbGenerateurs != premiere.nbGenerateurs
+            || lue.nbMetriques != premiere.nbMetriques) {
+            std::cerr << cheminDuShard << " n'appartient pas a la meme campagne que " << cheminShard(chemin, 0, nbShards) << '\n';
+            exit(EXIT_FAILURE);
+        }
+
+        const size_t nbCases = static_cast<size_t>(lue.nbLignes) * lue.nbTris * lue.nbGenerateurs;
+        const size_t casesDuShard = nbCases / nbShards + (shard < nbCases % nbShards ? 1 : 0);
+        const size_t parCase = static_cast<size_t>(lue.nbRepetitions) * lue.nbMetriques;
+        if (lecteurs.back().nbEnregistrements() < casesDuShard * parCase) {
+            std::cerr << cheminDuShard << " : " << lecteurs.back().nbEnregistrements() / parCase << " cases sur " << casesDuShard << '\n';
+            incomplet = true;
+        }
+    }
+
+    if (incomplet) {
+        std::cerr << "Shards incomplets : relancez-les avec --reprendre avant de fusionner\n";
+        exit(EXIT_FAILURE);
+    }
+
+    EnteteJournal entete = lecteurs.front().entete();
+    entete.shard = 0;                                            // Le journal fusionné est celui d'une campagne non découpée
+    entete.nbShards = 1;
+
+    std::ofstream out(chemin, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Impossible d'ouvrir le fichier " << chemin << '\n';
+        exit(EXIT_FAILURE);
+    }
+    out.write(reinterpret_cast<const char*>(&entete), sizeof(entete));
+
+    const size_t parCase = static_cast<size_t>(entete.nbRepetitions) * entete.nbMetriques;
+    const size_t nbCases = static_cast<size_t>(entete.nbLignes) * entete.nbTris * entete.nbGenerateurs;
+    std::vector<uint32_t> tailles(entete.nbLignes, 0);          // N de chaque ligne, 0 tant qu'aucun shard ne l'a donné
+    for (size_t numeroCase = 0; numeroCase < nbCases; numeroCase++) {
+        const uint16_t shard = static_cast<uint16_t>(numeroCase % nbShards);
+        const uint32_t ligne = static_cast<uint32_t>(numeroCase / (static_cast<size_t>(entete.nbTris) * entete.nbGenerateurs));
+        const uint16_t algo = static_cast<uint16_t>(numeroCase / entete.nbGenerateurs % entete.nbTris);
+        const uint16_t generateur = static_cast<uint16_t>(numeroCase % entete.nbGenerateurs);
+
+        for (size_t i = 0; i < parCase; i++) {
+            Enregistrement e;
+            lecteurs[shard].suivant(e);                          // Toujours présent : la taille des shards a été vérifiée
+            if (e.ligne != ligne || e.algo != algo || e.generateur != generateur) {
+                std::cerr << cheminShard(chemin, shard, nbShards) << " n'est pas dans l'ordre du balayage (case " << numeroCase << ")\n";
+                out.close();
+                std::filesystem::remove(chemin);
+                exit(EXIT_FAILURE);
+            }
+            if (tailles[ligne] != 0 && tailles[ligne] != e.N) {
+                std::cerr << cheminShard(chemin, shard, nbShards) << " n'a pas tire les memes N que les autres shards (ligne " << ligne
+                          << ") : tous les shards doivent etre executes par le meme programme sur la meme plateforme\n";
+                out.close();
+                std::filesystem::remove(chemin);
+                exit(EXIT_FAILURE);
+            }
+            tailles[ligne] = e.N;
+            out.write(reinterpret_cast<const char*>(&e), sizeof(e));
+        }
+    }
+}
+
+/**
+ * Exporte un journal au format de tri.csv : une ligne par N, une colonne par couple (génération, tri),
+ * avec le nombre de comparaisons de la première répétition. Les cases absentes restent vides.
+ *
+ * Le journal est lu un enregistrement à la fois : ses lignes se suivent dans l'ordre du balayage, et chaque
+ * ligne du CSV est écrite dès que le journal passe à la suivante.
+ *
+ * \param[in] chemin Le chemin du fichier CSV
+ * \param[in] cheminJournal Le chemin du journal
+ * \param[in] nomTrie Les noms des tris, dans l'ordre des indices des enregistrements
+ * \param[in] nomGenerateurs Les noms des méthodes de génération, dans l'ordre des indices des enregistrements
+ */
+void exporterCsv(const std::string& chemin, const std::string& cheminJournal,
+                 const std::vector<std::string>& nomTrie, const std::vector<std::string>& nomGenerateurs)
+{
+    LecteurJournal lecteur(cheminJournal);
+    std::ofstream out(chemin);
+    if (!out.is_open()) {
+        std::cerr << "Impossible d'ouvrir le fichier " << chemin << '\n';
+        exit(EXIT_FAILURE);
+    }
+
+    out << "N;";                                                 // Même entête que le balayage d'origine
+    for (const auto& algo : nomTrie)
+        for (const auto& generateur : nomGenerateurs)
+            out << generateur + " " + algo << ";";
+    out << "\n";
+
+    std::vector<std::string> cellules(nomTrie.size() * nomGenerateurs.size());     // Cellules de la ligne en cours
+    uint32_t ligneEnCours = 0;
+    uint32_t N = 0;                                              // N de la ligne en cours, 0 si elle n'a encore aucun enregistrement
+    const auto ecrireLigne = [&]() {
+        if (N == 0)
+            return;
+        out << N;
+        for (auto& cellule : cellules) {
+            out << ';' << cellule;
+            cellule.clear();
+        }
+        out << '\n';
+        N = 0;
+    };
+
+    Enregistrement e;
+    while (lecteur.suivant(e)) {
+        if (e.metrique != static_cast<uint8_t>(Metrique::Comparaisons) || e.repetition != 0 || e.algo >= nomTrie.size() || e.generateur >= nomGenerateurs.size())
+            continue;                                            // Seules les comparaisons de la première répétition vont dans le CSV
+        if (e.ligne != ligneEnCours)
+            ecrireLigne();
+        ligneEnCours = e.ligne;
+        N = e.N;
+        cellules[e.algo * nomGenerateurs.size() + e.generateur] = std::to_string(static_cast<unsigned int>(e.valeur));
+    }
+    ecrireLigne();
+}
+
+/**
+ * Exporte la mémoire auxiliaire et la récursion de chaque exécution d'un journal : une ligne par ligne du balayage,
+ * tri, génération et répétition, avec le pic d'octets auxiliaires, le nombre d'allocations et la profondeur
+ * de récursion maximale. Le journal est lu un enregistrement à la fois.
+ *
+ * \param[in] chemin Le chemin du fichier CSV
+ * \param[in] cheminJournal Le chemin du journal
+ * \param[in] nomTrie Les noms des tris, dans l'ordre des indices des enregistrements
+ * \param[in] nomGenerateurs Les noms des méthodes de génération, dans l'ordre des indices des enregistrements
+ */
+void exporterMemoireCsv(const std::string& chemin, const std::string& cheminJournal,
+                        const std::vector<std::string>& nomTrie, const std::vector<std::string>& nomGenerateurs)
+{
+    LecteurJournal lecteur(cheminJournal);
+    std::ofstream out(chemin);
+    if (!out.is_open()) {
+        std::cerr << "Impossible d'ouvrir le fichier " << chemin << '\n';
+        exit(EXIT_FAILURE);
+    }
+
+    out << "N;Algo;Generateur;Repetition;OctetsPic;NbAllocations;ProfondeurMax\n";
+    Enregistrement precedents[2] = {};                           // Les deux enregistrements lus avant e
+    size_t nbLus = 0;
+    Enregistrement e;
+    while (lecteur.suivant(e)) {                                 // Les métriques d'une exécution se suivent
+        const Enregistrement& premier = precedents[0];
+        if (nbLus >= 2 && premier.metrique == static_cast<uint8_t>(Metrique::OctetsPic)
+            && precedents[1].metrique == static_cast<uint8_t>(Metrique::NbAllocations)
+            && e.metrique == static_cast<uint8_t>(Metrique::ProfondeurMax)
+            && premier.algo < nomTrie.size() && premier.generateur < nomGenerateurs.size()) {
+            out << premier.N << ';' << nomTrie[premier.algo] << ';' << nomGenerateurs[premier.generateur] << ';' << premier.repetition;
+            for (const Enregistrement* m : { &precedents[0], &precedents[1], &e })
+                out << ';' << static_cast<unsigned long long>(m->valeur);
+            out << '\n';
+        }                                                        // Les journaux d'avant le suivi de la mémoire n'ont pas ces métriques
+        precedents[0] = precedents[1];
+        precedents[1] = e;
+        nbLus++;
+    }
+}
+
+/**
+ * Ouvre le journal. En reprise, si le journal existe, ses paramètres remplacent ceux de l'entête donnée,
+ * les cases terminées sont comptées d'après la taille du fichier et il est tronqué après la dernière case terminée. Un journal écrit
+ * par une version précédente, avec d'autres métriques, peut être exporté mais pas repris.
+ * Sinon un nouveau journal est créé.
+ *
+ * \param[in] chemin Le chemin du journal
+ * \param[in,out] entete L'entête de la campagne demandée, remplacée par celle du journal en cas de reprise
+ * \param[in] nbMetriques Le nombre de métriques enregistrées par répétition
+ * \param[in] reprendre Vrai pour reprendre un journal existant
+ * \param[in] intervalleSynchro Le nombre de secondes entre deux écritures forcées sur le disque
+ */
+Journal::Journal(const std::string& chemin, EnteteJournal& entete, size_t nbMetriques, bool reprendre, double intervalleSynchro)
+    : chemin(chemin), fichier(nullptr), casesTerminees(0), intervalleSynchro(intervalleSynchro),
+      derniereSynchro(std::chrono::steady_clock::now())
+{
+    if (reprendre && std::filesystem::exists(chemin)) {
+        EnteteJournal lue;
+        size_t nbEnregistrements;
+        {                                                        // Le journal est refermé avant d'être tronqué
+            LecteurJournal lecteur(chemin);
+            lue = lecteur.entete();
+            nbEnregistrements = lecteur.nbEnregistrements();
+        }
+        verifierBalayage(chemin, lue, entete.nbTris, entete.nbGenerateurs);
+        if (lue.shard != entete.shard || lue.nbShards != entete.nbShards) {
+            std::cerr << "Le journal " << chemin << " a ete ecrit pour un autre shard\n";
+            exit(EXIT_FAILURE);
+        }
+        if (lue.nbMetriques != nbMetriques) {
+            std::cerr << "Le journal " << chemin << " a ete ecrit avec " << lue.nbMetriques << " metriques au lieu de " << nbMetriques
+                      << " : il ne peut pas etre repris, seulement exporte avec --exporter\n";
+            exit(EXIT_FAILURE);
+        }
+        entete = lue;
+
+        const size_t parCase = entete.nbRepetitions * nbMetriques;
+        casesTerminees = nbEnregistrements / parCase;           // Les cases terminées sont comptées sans être relues
+        std::filesystem::resize_file(chemin, sizeof(EnteteJournal) + casesTerminees * parCase * sizeof(Enregistrement));
+        fichier = std::fopen(chemin.c_str(), "ab");
+    }
+    else {
+        fichier = std::fopen(chemin.c_str(), "wb");
+        if (fichier != nullptr)
+            std::fwrite(&entete, sizeof(entete), 1, fichier);
+    }
+
+    if (fichier == nullptr) {
+        std::cerr << "Impossible d'ouvrir le fichier " << chemin << '\n';
+        exit(EXIT_FAILURE);
+    }
+    synchroniser();
+}
+
+/**
+ * Ferme le journal après une dernière synchronisation.
+ */
+Journal::~Journal()
+{
+    synchroniser();
+    std::fclose(fichier);
+}
+
+/**
+ * Ajoute un enregistrement à la case en cours. Il est transmis au système au plus tard à la fin de la case.
+ *
+ * \param[in] enregistrement L'enregistrement à ajouter
+ */
+void Journal::ajouter(const Enregistrement& enregistrement)
+{
+    if (std::fwrite(&enregistrement, sizeof(enregistrement), 1, fichier) != 1) {
+        std::cerr << "Erreur d'ecriture dans " << chemin << '\n';
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Termine la case en cours : ses enregistrements sont transmis au système, et le journal est écrit
+ * sur le disque si la dernière synchronisation date de plus de intervalleSynchro secondes.
+ */
+void Journal::terminerCase()
+{
+    casesTerminees++;
+    std::fflush(fichier);
+    const std::chrono::duration<double> ecoule = std::chrono::steady_clock::now() - derniereSynchro;
+    if (ecoule.count() >= intervalleSynchro)
+        synchroniser();
+}
+
+/**
+ * Force l'écriture du journal sur le disque, pour qu'il survive à un arrêt brutal de la machine.
+ */
+void Journal::synchroniser()
+{
+    std::fflush(fichier);
+#ifdef _WIN32
+    _commit(_fileno(fichier));
+#else
+    fsync(fileno(fichier));
+#endif // _WIN32
+    derniereSynchro = std::chrono::steady_clock::now();
+}
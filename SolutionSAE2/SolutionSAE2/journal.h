@@ -0,0 +1,113 @@
+/**
+ * \file journal.h
+ *
+ * Déclaration du journal binaire des résultats et de son export CSV.
+ */
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+#include <fstream>
+
+//!\brief Entête du journal : les paramètres qui permettent de rejouer exactement la même campagne
+struct EnteteJournal {
+    char magie[4];
+    uint32_t version;
+    uint32_t graine;
+    uint32_t nbLignes;
+    uint32_t nbRepetitions;
+    uint16_t nbTris;
+    uint16_t nbGenerateurs;
+    uint16_t shard;
+    uint16_t nbShards;
+    uint32_t nbMetriques;
+};
+static_assert(sizeof(EnteteJournal) == 32, "L'entete du journal doit faire 32 octets");
+
+//!\brief Un enregistrement : une métrique d'une répétition d'une case (ligne, tri, génération)
+struct Enregistrement {
+    uint16_t algo;
+    uint16_t generateur;
+    uint32_t ligne;
+    uint32_t N;
+    uint16_t repetition;
+    uint8_t metrique;
+    uint8_t reserve;
+    double valeur;
+};
+static_assert(sizeof(Enregistrement) == 24, "Un enregistrement du journal doit faire 24 octets");
+
+//!\brief Crée l'entête d'un nouveau journal
+EnteteJournal creerEntete(uint32_t graine, uint32_t nbLignes, uint32_t nbRepetitions, uint16_t nbTris, uint16_t nbGenerateurs,
+                          uint16_t shard = 0, uint16_t nbShards = 1);
+
+//!\brief Donne le chemin du journal d'un shard à partir du chemin du journal complet
+std::string cheminShard(const std::string& chemin, uint16_t shard, uint16_t nbShards);
+
+//!\brief Indique si une case du balayage appartient à un shard
+bool caseDuShard(size_t numeroCase, uint16_t shard, uint16_t nbShards);
+
+//!\brief Termine le programme si un journal n'a pas été écrit avec les mêmes tris et générations que ce programme ou a trop de répétitions
+void verifierBalayage(const std::string& chemin, const EnteteJournal& entete, uint16_t nbTris, uint16_t nbGenerateurs);
+
+//!\brief Réunit les journaux de tous les shards d'une campagne dans le journal complet
+void fusionnerShards(const std::string& chemin, uint16_t nbShards);
+
+//!\brief Exporte un journal au format de tri.csv
+void exporterCsv(const std::string& chemin, const std::string& cheminJournal,
+                 const std::vector<std::string>& nomTrie, const std::vector<std::string>& nomGenerateurs);
+
+//!\brief Exporte la mémoire et la récursion de chaque exécution d'un journal dans un CSV
+void exporterMemoireCsv(const std::string& chemin, const std::string& cheminJournal,
+                        const std::vector<std::string>& nomTrie, const std::vector<std::string>& nomGenerateurs);
+
+//!\brief Lecture d'un journal un enregistrement à la fois, sans le charger en mémoire
+class LecteurJournal {
+public:
+    explicit LecteurJournal(const std::string& chemin);
+
+    //!\brief Entête du journal, dans la mise en page de la version courante
+    const EnteteJournal& entete() const { return lue; }
+
+    //!\brief Nombre d'enregistrements complets du journal
+    size_t nbEnregistrements() const { return nombre; }
+
+    //!\brief Lit l'enregistrement suivant, renvoie faux à la fin du journal
+    bool suivant(Enregistrement& enregistrement);
+
+private:
+    std::ifstream in;
+    EnteteJournal lue;
+    size_t nombre;
+    size_t nbLus;
+};
+
+//!\brief Journal binaire en ajout seul, synchronisé sur le disque à intervalles réguliers
+class Journal {
+public:
+    Journal(const std::string& chemin, EnteteJournal& entete, size_t nbMetriques, bool reprendre, double intervalleSynchro);
+    ~Journal();
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    //!\brief Nombre de cases déjà terminées dans le journal (à sauter lors d'une reprise)
+    size_t nbCasesTerminees() const { return casesTerminees; }
+
+    //!\brief Ajoute un enregistrement à la case en cours
+    void ajouter(const Enregistrement& enregistrement);
+
+    //!\brief Termine la case en cours et synchronise le disque si l'intervalle est écoulé
+    void terminerCase();
+
+    //!\brief Force l'écriture du journal sur le disque
+    void synchroniser();
+
+private:
+    std::string chemin;
+    FILE* fichier;
+    size_t casesTerminees;
+    double intervalleSynchro;
+    std::chrono::steady_clock::time_point derniereSynchro;
+};
@@ -0,0 +1,11 @@
+/**
+ * \file memoire.cpp
+ *
+ * Définition des statistiques de mémoire auxiliaire et de récursion des tris.
+ *
+ * Seuls les tableaux déclarés en VecteurCompte dans les tris sont comptés : le tableau à trier
+ * n'est pas de la mémoire auxiliaire.
+ */
+#include "memoire.h"
+
+StatsMemoire statsMemoire = {};
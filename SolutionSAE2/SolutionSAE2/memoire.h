@@ -0,0 +1,90 @@
+/**
+ * \file memoire.h
+ *
+ * Déclaration du suivi de la mémoire auxiliaire et de la profondeur de récursion des tris.
+ *
+ * Les fonctions de comptage sont appelées dans la partie chronométrée des tris : elles sont définies
+ * ici, en ligne, pour ne coûter que quelques additions et ne pas fausser la métrique Temps.
+ */
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <algorithm>
+
+//!\brief Mémoire auxiliaire et récursion observées depuis la dernière remise à zéro
+struct StatsMemoire {
+    size_t octetsCourants;
+    size_t octetsPic;
+    size_t nbAllocations;
+    unsigned int profondeur;
+    unsigned int profondeurMax;
+};
+
+//!\brief Statistiques du tri en cours
+extern StatsMemoire statsMemoire;
+
+//!\brief Remet les statistiques à zéro avant un tri
+inline void reinitialiserMemoire()
+{
+    statsMemoire = {};
+}
+
+//!\brief Compte une allocation de la mémoire auxiliaire et met à jour le pic
+inline void compterAllocation(size_t octets)
+{
+    statsMemoire.octetsCourants += octets;
+    statsMemoire.octetsPic = std::max(statsMemoire.octetsPic, statsMemoire.octetsCourants);
+    statsMemoire.nbAllocations++;
+}
+
+//!\brief Compte une libération de la mémoire auxiliaire
+inline void compterLiberation(size_t octets)
+{
+    statsMemoire.octetsCourants -= std::min(octets, statsMemoire.octetsCourants);
+}
+
+//!\brief Allocateur qui compte les octets alloués par les tableaux auxiliaires des tris
+template <class T>
+struct AllocateurCompteur {
+    using value_type = T;
+
+    AllocateurCompteur() = default;
+    template <class U>
+    AllocateurCompteur(const AllocateurCompteur<U>&) {}
+
+    T* allocate(size_t n)
+    {
+        compterAllocation(n * sizeof(T));
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        compterLiberation(n * sizeof(T));
+        std::allocator<T>().deallocate(p, n);
+    }
+};
+
+template <class T, class U>
+bool operator==(const AllocateurCompteur<T>&, const AllocateurCompteur<U>&) { return true; }
+
+template <class T, class U>
+bool operator!=(const AllocateurCompteur<T>&, const AllocateurCompteur<U>&) { return false; }
+
+//!\brief Tableau auxiliaire d'un tri, compté dans les statistiques
+using VecteurCompte = std::vector<int, AllocateurCompteur<int>>;
+
+//!\brief Compte un niveau de récursion tant qu'il existe
+struct GardeProfondeur {
+    GardeProfondeur()
+    {
+        statsMemoire.profondeur++;
+        statsMemoire.profondeurMax = std::max(statsMemoire.profondeurMax, statsMemoire.profondeur);
+    }
+
+    ~GardeProfondeur()
+    {
+        statsMemoire.profondeur--;
+    }
+};
@@ -0,0 +1,477 @@
+/**
+ * \file regression.cpp
+ *
+ * Définition des fonctions d'ajustement et de détection de régressions de performance.
+ *
+ * Chaque série (tri, génération de tableau, métrique) est ajustée par une loi puissance
+ * valeur + 1 = constante * N^exposant, par moindres carrés sur ln(N) et ln(valeur + 1).
+ * Le +1 permet de garder les séries qui valent 0 (tri à bulles optimisé sur un tableau presque trié).
+ */
+#include "regression.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+//!\brief Première ligne d'un fichier de référence
+static const char ENTETE_REFERENCE[] = "Algo;Generateur;Metrique;Exposant;Constante;ErreurExposant;EcartResiduel;NbPoints;MoyenneLogN;SxxLogN;EcartExecutions";
+
+//!\brief Nombre maximal de blocs consécutifs du balayage pour estimer la variation d'une exécution à l'autre
+constexpr size_t NB_BLOCS = 8;
+
+/**
+ * Donne le nom d'une métrique tel qu'il est écrit dans le fichier de référence.
+ *
+ * \param[in] metrique La métrique
+ * \return le nom de la métrique
+ */
+std::string nomMetrique(Metrique metrique)
+{
+    switch (metrique) {
+    case Metrique::Comparaisons: return "Comparaisons";
+    case Metrique::Temps:        return "Temps";
+    case Metrique::OctetsPic:     return "OctetsPic";
+    case Metrique::NbAllocations: return "NbAllocations";
+    case Metrique::ProfondeurMax: return "ProfondeurMax";
+    }
+    return {};
+}
+
+/**
+ * Retrouve une métrique à partir de son nom.
+ *
+ * \param[in] nom Le nom lu dans un fichier
+ * \param[out] metrique La métrique correspondante
+ * \return vrai si le nom correspond à une métrique connue
+ */
+bool metriqueDepuisNom(const std::string& nom, Metrique& metrique)
+{
+    for (Metrique m : { Metrique::Comparaisons, Metrique::Temps, Metrique::OctetsPic, Metrique::NbAllocations, Metrique::ProfondeurMax }) {
+        if (nomMetrique(m) == nom) {
+            metrique = m;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Quantile à 97,5 % de la loi de Student, utilisé pour les intervalles de confiance à 95 %.
+ *
+ * Valeurs exactes jusqu'à 3 degrés de liberté, où l'approximation de Cornish-Fisher autour du quantile
+ * de la loi normale sous-estime nettement le quantile (9,7 au lieu de 12,7 pour 1 degré), puis
+ * cette approximation, précise au centième au-delà.
+ *
+ * \param[in] ddl Le nombre de degrés de liberté
+ * \return le quantile
+ */
+static double quantileStudent(size_t ddl)
+{
+    const double exacts[] = { 12.706205, 4.302653, 3.182446 };
+    if (ddl <= 3)
+        return exacts[ddl < 1 ? 0 : ddl - 1];
+
+    const double z = 1.959964;
+    const double v = static_cast<double>(ddl);
+    const double z3 = z * z * z, z5 = z3 * z * z, z7 = z5 * z * z;
+    return z + (z3 + z) / (4 * v)
+             + (5 * z5 + 16 * z3 + 3 * z) / (96 * v * v)
+             + (3 * z7 + 19 * z5 + 17 * z3 - 15 * z) / (384 * v * v * v);
+}
+
+/**
+ * Indique si une mesure appartient à la série d'un ajustement.
+ */
+static bool memeSerie(const Mesure& mesure, const Ajustement& ajustement)
+{
+    return mesure.metrique == ajustement.metrique && mesure.algo == ajustement.algo && mesure.generateur == ajustement.generateur;
+}
+
+/**
+ * Remplace les temps des répétitions d'une même case (série et ligne du balayage) par leur médiane, qui devient
+ * un seul point.
+ *
+ * Les répétitions d'un temps ne sont pas indépendantes (même processeur, même état des caches au même moment) :
+ * les compter comme autant de points rendrait l'intervalle de confiance trop étroit, et une seule valeur
+ * aberrante déplacerait la moyenne. Les autres métriques, déterministes, ne sont pas modifiées.
+ * Les temps sont placés après les autres mesures.
+ *
+ * \param[in,out] mesures Les mesures
+ */
+void regrouperTemps(std::vector<Mesure>& mesures)
+{
+    const auto debut = std::stable_partition(mesures.begin(), mesures.end(), [](const Mesure& m) { return m.metrique != Metrique::Temps; });
+    std::sort(debut, mesures.end(), [](const Mesure& a, const Mesure& b) {
+        if (a.algo != b.algo) return a.algo < b.algo;
+        if (a.generateur != b.generateur) return a.generateur < b.generateur;
+        if (a.ligne != b.ligne) return a.ligne < b.ligne;
+        return a.valeur < b.valeur;
+    });
+
+    auto fin = debut;                                // Fin des médianes déjà écrites
+    for (auto i = debut; i != mesures.end();) {
+        auto j = i;
+        while (j != mesures.end() && j->algo == i->algo && j->generateur == i->generateur && j->ligne == i->ligne)
+            j++;
+        const auto n = j - i;
+        Mesure mediane = *(i + n / 2);
+        if (n % 2 == 0)
+            mediane.valeur = ((i + n / 2 - 1)->valeur + mediane.valeur) / 2;
+        *fin++ = mediane;
+        i = j;
+    }
+    mesures.erase(fin, mesures.end());
+}
+
+/**
+ * Estime la variation du niveau des temps d'une exécution à l'autre à partir d'une seule exécution.
+ *
+ * Les résidus sont rangés dans l'ordre du balayage et découpés en blocs consécutifs : l'écart type des moyennes
+ * des blocs mesure de combien le niveau des temps dérive au cours de l'exécution (fréquence du processeur,
+ * autres processus, état de la mémoire), ce qu'une autre exécution subit aussi.
+ *
+ * \param[in] residus Les couples (ligne du balayage, résidu en log) d'une série
+ * \return l'écart type des moyennes des blocs, en log
+ */
+static double ecartEntreBlocs(std::vector<std::pair<uint32_t, double>> residus)
+{
+    const size_t nbBlocs = std::min(NB_BLOCS, residus.size());
+    if (nbBlocs < 2)
+        return 0;
+    std::sort(residus.begin(), residus.end());
+
+    std::vector<double> moyennes(nbBlocs, 0);
+    for (size_t b = 0; b < nbBlocs; b++) {
+        const size_t debut = b * residus.size() / nbBlocs, fin = (b + 1) * residus.size() / nbBlocs;
+        for (size_t i = debut; i < fin; i++)
+            moyennes[b] += residus[i].second;
+        moyennes[b] /= fin - debut;
+    }
+
+    double moyenne = 0, variance = 0;
+    for (double m : moyennes)
+        moyenne += m / nbBlocs;
+    for (double m : moyennes)
+        variance += (m - moyenne) * (m - moyenne) / (nbBlocs - 1);
+    return std::sqrt(variance);
+}
+
+/**
+ * Ajuste une loi puissance sur chaque série de mesures (même tri, même génération, même métrique).
+ *
+ * Les séries de moins de 3 points ou dont tous les points ont le même N ne sont pas ajustées. Les séries de temps
+ * dont la durée moyenne (géométrique) est inférieure à DUREE_MIN_TEMPS ne le sont pas non plus : à cette échelle,
+ * la lecture de l'horloge, les caches et la fréquence du processeur varient plus d'une exécution à l'autre que
+ * ce que l'intervalle de confiance d'une seule exécution peut mesurer. Pour les autres séries de temps, la dérive
+ * au cours de l'exécution est gardée dans ecartExecutions ; elle est nulle pour les métriques déterministes.
+ *
+ * \param[in] mesures Les mesures, dans n'importe quel ordre
+ * \return un ajustement par série, dans l'ordre d'apparition des séries
+ */
+std::vector<Ajustement> ajusterMesures(const std::vector<Mesure>& mesures)
+{
+    std::vector<Ajustement> series;
+    std::vector<std::vector<const Mesure*>> points;
+
+    for (const auto& mesure : mesures) {             // On regroupe les mesures par série
+        size_t s = 0;
+        while (s < series.size() && !memeSerie(mesure, series[s]))
+            s++;
+        if (s == series.size()) {
+            Ajustement a{};
+            a.algo = mesure.algo;
+            a.generateur = mesure.generateur;
+            a.metrique = mesure.metrique;
+            series.push_back(a);
+            points.emplace_back();
+        }
+        points[s].push_back(&mesure);
+    }
+
+    std::vector<Ajustement> ajustements;
+    for (size_t s = 0; s < series.size(); s++) {
+        const size_t n = points[s].size();
+        if (n < 3)
+            continue;
+
+        double moyenneX = 0, moyenneY = 0;
+        for (const Mesure* p : points[s]) {
+            moyenneX += std::log(static_cast<double>(p->N));
+            moyenneY += std::log(p->valeur + 1);
+        }
+        moyenneX /= n;
+        moyenneY /= n;
+        if (series[s].metrique == Metrique::Temps && std::exp(moyenneY) - 1 < DUREE_MIN_TEMPS)
+            continue;
+
+        double sxx = 0, sxy = 0;
+        for (const Mesure* p : points[s]) {
+            const double dx = std::log(static_cast<double>(p->N)) - moyenneX;
+            sxx += dx * dx;
+            sxy += dx * (std::log(p->valeur + 1) - moyenneY);
+        }
+        if (sxx <= 0)
+            continue;
+
+        Ajustement a = series[s];
+        a.exposant = sxy / sxx;
+        a.logConstante = moyenneY - a.exposant * moyenneX;
+
+        double sommeResidus = 0;                     // Somme des carrés des résidus
+        std::vector<std::pair<uint32_t, double>> residus;
+        for (const Mesure* p : points[s]) {
+            const double r = std::log(p->valeur + 1) - (a.logConstante + a.exposant * std::log(static_cast<double>(p->N)));
+            sommeResidus += r * r;
+            residus.emplace_back(p->ligne, r);
+        }
+        a.ecartExecutions = a.metrique == Metrique::Temps ? ecartEntreBlocs(residus) : 0;
+        a.ecartResiduel = std::sqrt(sommeResidus / (n - 2));
+        a.erreurExposant = a.ecartResiduel / std::sqrt(sxx);
+        a.nbPoints = n;
+        a.moyenneLogN = moyenneX;
+        a.sxx = sxx;
+        ajustements.push_back(a);
+    }
+    return ajustements;
+}
+
+/**
+ * Écrit les ajustements dans un fichier CSV de référence, relu par lireReference lors des exécutions suivantes.
+ * Les tris et les générations y sont écrits par leur nom, qui ne dépend pas de leur place dans le balayage.
+ *
+ * \param[in] chemin Le chemin du fichier
+ * \param[in] ajustements Les ajustements à enregistrer
+ * \param[in] nomTrie Les noms des tris, dans l'ordre de leurs indices
+ * \param[in] nomGenerateurs Les noms des méthodes de génération, dans l'ordre de leurs indices
+ */
+void ecrireReference(const std::string& chemin, const std::vector<Ajustement>& ajustements,
+                     const std::vector<std::string>& nomTrie, const std::vector<std::string>& nomGenerateurs)
+{
+    std::ofstream out(chemin);
+    if (!out.is_open()) {
+        std::cerr << "Impossible d'ouvrir le fichier " << chemin << '\n';
+        exit(EXIT_FAILURE);
+    }
+
+    out << ENTETE_REFERENCE << '\n';
+    out << std::setprecision(17);
+    for (const auto& a : ajustements) {
+        out << nomTrie[a.algo] << ';' << nomGenerateurs[a.generateur] << ';' << nomMetrique(a.metrique) << ';'
+            << a.exposant << ';' << std::exp(a.logConstante) << ';' << a.erreurExposant << ';'
+            << a.ecartResiduel << ';' << a.nbPoints << ';' << a.moyenneLogN << ';' << a.sxx << ';' << a.ecartExecutions << '\n';
+    }
+}
+
+/**
+ * Lit un nombre fini qui occupe tout un champ d'un fichier de référence.
+ *
+ * \param[in] champ Le champ lu
+ * \param[out] valeur Le nombre
+ * \return faux si le champ n'est pas un nombre fini
+ */
+static bool lireNombre(const std::string& champ, double& valeur)
+{
+    try {
+        size_t lus = 0;
+        valeur = std::stod(champ, &lus);
+        return lus == champ.size() && std::isfinite(valeur);
+    }
+    catch (const std::exception&) {                              // Ni un nombre ni représentable
+        return false;
+    }
+}
+
+/**
+ * Lit un fichier de référence écrit par ecrireReference. Le programme est terminé si le fichier
+ * est absent, mal formé, vide ou nomme un tri ou une génération que ce programme ne connaît pas.
+ *
+ * \param[in] chemin Le chemin du fichier
+ * \param[in] nomTrie Les noms des tris, dans l'ordre de leurs indices
+ * \param[in] nomGenerateurs Les noms des méthodes de génération, dans l'ordre de leurs indices
+ * \return les ajustements de référence
+ */
+std::vector<Ajustement> lireReference(const std::string& chemin,
+                                      const std::vector<std::string>& nomTrie, const std::vector<std::string>& nomGenerateurs)
+{
+    std::ifstream in(chemin);
+    if (!in.is_open()) {
+        std::cerr << "Impossible d'ouvrir le fichier " << chemin << '\n';
+        exit(EXIT_FAILURE);
+    }
+
+    std::vector<Ajustement> reference;
+    std::string ligne;
+    bool entete = true;
+    while (std::getline(in, ligne)) {
+        if (!ligne.empty() && ligne.back() == '\r')            // Fichier enregistré avec des fins de ligne Windows
+            ligne.pop_back();
+        if (entete) {
+            if (ligne != ENTETE_REFERENCE) {
+                std::cerr << chemin << " n'est pas un fichier de reference de cette version, regenerez-le avec --reference-ecrire\n";
+                exit(EXIT_FAILURE);
+            }
+            entete = false;
+            continue;
+        }
+        if (ligne.empty())
+            continue;
+
+        std::vector<std::string> champs;
+        std::istringstream flux(ligne);
+        std::string champ;
+        while (std::getline(flux, champ, ';'))
+            champs.push_back(champ);
+
+        Ajustement a{};
+        double constante = 0, nbPoints = 0;
+        const bool valide = champs.size() == 11 && metriqueDepuisNom(champs[2], a.metrique)
+            && lireNombre(champs[3], a.exposant) && lireNombre(champs[4], constante) && lireNombre(champs[5], a.erreurExposant)
+            && lireNombre(champs[6], a.ecartResiduel) && lireNombre(champs[7], nbPoints) && lireNombre(champs[8], a.moyenneLogN)
+            && lireNombre(champs[9], a.sxx) && lireNombre(champs[10], a.ecartExecutions)
+            && constante > 0 && a.erreurExposant >= 0 && a.ecartResiduel >= 0 && a.ecartExecutions >= 0
+            && nbPoints >= 3 && nbPoints == std::floor(nbPoints) && a.sxx > 0;   // Comme les séries retenues par ajusterMesures
+        if (!valide) {
+            std::cerr << "Ligne invalide dans " << chemin << " : " << ligne << '\n';
+            exit(EXIT_FAILURE);
+        }
+        a.logConstante = std::log(constante);
+        a.nbPoints = static_cast<size_t>(nbPoints);
+
+        const auto algo = std::find(nomTrie.begin(), nomTrie.end(), champs[0]);
+        const auto generateur = std::find(nomGenerateurs.begin(), nomGenerateurs.end(), champs[1]);
+        if (algo == nomTrie.end() || generateur == nomGenerateurs.end()) {
+            std::cerr << "Tri ou generation inconnu dans " << chemin << " : " << ligne << '\n';
+            exit(EXIT_FAILURE);
+        }
+        a.algo = static_cast<uint16_t>(algo - nomTrie.begin());
+        a.generateur = static_cast<uint16_t>(generateur - nomGenerateurs.begin());
+        reference.push_back(a);
+    }
+
+    if (reference.empty()) {                         // Une référence vide laisserait passer n'importe quelle mesure
+        std::cerr << chemin << " ne contient aucune serie de reference\n";
+        exit(EXIT_FAILURE);
+    }
+    return reference;
+}
+
+/**
+ * Compare des mesures à une référence et écrit un rapport par série.
+ *
+ * Pour chaque série, on calcule l'écart moyen (en log) entre les nouvelles mesures et la loi de référence,
+ * c'est-à-dire le facteur de ralentissement, avec son intervalle de confiance à 95 %. L'incertitude combine
+ * la dispersion des nouvelles mesures et celle de l'ajustement de référence au N moyen des nouvelles mesures.
+ * Pour les temps, elle comprend aussi la variation d'une exécution à l'autre, estimée par ecartEntreBlocs dans
+ * l'exécution de référence et dans la nouvelle : cette part ne diminue pas avec le nombre de mesures.
+ * Une série est en régression si la borne basse de l'intervalle dépasse 1 + tolerance. Les temps varient d'une
+ * exécution à l'autre (fréquence du processeur, autres processus) : ils ont leur propre tolérance, plus large.
+ *
+ * Les temps doivent avoir été regroupés par regrouperTemps, comme pour l'écriture de la référence.
+ *
+ * Une série de la référence sans aucune nouvelle mesure (tri renommé, génération retirée) ou dont l'intervalle
+ * n'est pas calculable n'est pas considérée comme valide : la vérification est alors incomplète. C'est aussi le cas
+ * d'une série de temps devenue plus courte que DUREE_MIN_TEMPS. Seules les séries de temps peuvent être écartées
+ * volontairement, avec avecTemps.
+ *
+ * \param[in] reference Les ajustements de référence
+ * \param[in] mesures Les nouvelles mesures
+ * \param[in] nomTrie Les noms des tris, pour le rapport
+ * \param[in] nomGenerateurs Les noms des méthodes de génération, pour le rapport
+ * \param[in] tolerance Le ralentissement relatif accepté sur le nombre de comparaisons (0.1 pour 10 %)
+ * \param[in] toleranceTemps Le ralentissement relatif accepté sur le temps
+ * \param[in] avecTemps Faux si les mesures ne contiennent volontairement pas de temps (campagne fusionnée)
+ * \param[out] rapport Le flux où écrire le rapport
+ * \return Regression si au moins une série est en régression, sinon Incomplet si une série n'a pas pu être comparée
+ */
+Verdict verifierReference(const std::vector<Ajustement>& reference, const std::vector<Mesure>& mesures,
+                          const std::vector<std::string>& nomTrie, const std::vector<std::string>& nomGenerateurs,
+                          double tolerance, double toleranceTemps, bool avecTemps, std::ostream& rapport)
+{
+    const std::vector<Ajustement> nouveaux = ajusterMesures(mesures);
+    const auto cle = [&](uint16_t algo, uint16_t generateur, Metrique metrique) {
+        return (static_cast<size_t>(algo) * nomGenerateurs.size() + generateur) * NB_METRIQUES + static_cast<size_t>(metrique);
+    };
+
+    std::vector<size_t> serieDe(nomTrie.size() * nomGenerateurs.size() * NB_METRIQUES, reference.size());  // Série de référence de chaque clé
+    for (size_t s = 0; s < reference.size(); s++)
+        serieDe[cle(reference[s].algo, reference[s].generateur, reference[s].metrique)] = s;
+
+    struct Residus {
+        double sommeR, sommeR2, sommeX, sommeY;
+        size_t m;
+    };
+    std::vector<Residus> residus(reference.size(), Residus{ 0, 0, 0, 0, 0 });
+    std::vector<std::vector<std::pair<uint32_t, double>>> residusTemps(reference.size());
+    for (const auto& mesure : mesures) {             // Un seul passage sur les mesures
+        const size_t s = serieDe[cle(mesure.algo, mesure.generateur, mesure.metrique)];
+        if (s == reference.size())
+            continue;
+        const Ajustement& ref = reference[s];
+        const double x = std::log(static_cast<double>(mesure.N));
+        const double y = std::log(mesure.valeur + 1);
+        const double r = y - (ref.logConstante + ref.exposant * x);
+        residus[s].sommeR += r;
+        residus[s].sommeR2 += r * r;
+        residus[s].sommeX += x;
+        residus[s].sommeY += y;
+        if (mesure.metrique == Metrique::Temps)
+            residusTemps[s].emplace_back(mesure.ligne, r);
+        residus[s].m++;
+    }
+
+    bool regression = false, incomplet = false;
+    rapport << std::fixed << std::setprecision(3);
+    for (size_t s = 0; s < reference.size(); s++) {
+        const Ajustement& ref = reference[s];
+        const size_t m = residus[s].m;
+        rapport << nomTrie[ref.algo] << ' ' << nomGenerateurs[ref.generateur] << ' ' << nomMetrique(ref.metrique) << " : ";
+        if (!avecTemps && ref.metrique == Metrique::Temps) {
+            rapport << "ignoree (campagne fusionnee)\n";
+            continue;
+        }
+        if (m == 0) {
+            rapport << "aucune mesure -> ABSENTE\n";
+            incomplet = true;
+            continue;
+        }
+        if (ref.metrique == Metrique::Temps && std::exp(residus[s].sommeY / m) - 1 < DUREE_MIN_TEMPS) {
+            rapport << "temps trop courts pour etre compares -> INDETERMINE\n";
+            incomplet = true;
+            continue;
+        }
+
+        const double moyenneR = residus[s].sommeR / m;
+        const double varianceR = m > 1 ? std::max(0.0, (residus[s].sommeR2 - m * moyenneR * moyenneR) / (m - 1)) : 0;
+        const double dx = residus[s].sommeX / m - ref.moyenneLogN;
+        const double ecartExecutions = ecartEntreBlocs(residusTemps[s]);
+        const double erreur = std::sqrt(varianceR / m + ref.ecartResiduel * ref.ecartResiduel * (1.0 / ref.nbPoints + dx * dx / ref.sxx)
+                                        + ref.ecartExecutions * ref.ecartExecutions + ecartExecutions * ecartExecutions);
+        const double t = quantileStudent(m - 1 + ref.nbPoints - 2);
+        const double basse = std::exp(moyenneR - t * erreur);
+        const double haute = std::exp(moyenneR + t * erreur);
+        if (!std::isfinite(moyenneR) || !std::isfinite(erreur) || !std::isfinite(haute)) {
+            rapport << "intervalle non calculable -> INDETERMINE\n";  // Une comparaison avec NaN serait toujours fausse
+            incomplet = true;
+            continue;
+        }
+        const bool ralenti = basse > 1 + (ref.metrique == Metrique::Temps ? toleranceTemps : tolerance);
+
+        rapport << "facteur " << std::exp(moyenneR) << " [" << basse << " ; " << haute << "]";
+        for (const auto& a : nouveaux) {
+            if (a.algo == ref.algo && a.generateur == ref.generateur && a.metrique == ref.metrique)
+                rapport << ", exposant " << a.exposant << " +/- " << quantileStudent(a.nbPoints - 2) * a.erreurExposant
+                        << " (reference " << ref.exposant << ")";
+        }
+        rapport << (ralenti ? " -> REGRESSION\n" : " -> ok\n");
+        regression = regression || ralenti;
+    }
+
+    if (regression)
+        return Verdict::Regression;
+    return incomplet ? Verdict::Incomplet : Verdict::Ok;
+}
@@ -0,0 +1,78 @@
+/**
+ * \file regression.h
+ *
+ * Déclaration des fonctions d'ajustement et de détection de régressions de performance.
+ */
+#pragma once
+#include <vector>
+#include <string>
+#include <ostream>
+#include <cstdint>
+
+//!\brief Code de sortie du programme lorsqu'une régression est détectée
+constexpr int CODE_REGRESSION = 2;
+
+//!\brief Code de sortie du programme lorsqu'une série de la référence n'a pas pu être comparée
+constexpr int CODE_INCOMPLET = 3;
+
+//!\brief Résultat de la comparaison à une référence
+enum class Verdict { Ok, Regression, Incomplet };
+
+//!\brief Grandeurs mesurées pour chaque tri
+enum class Metrique { Comparaisons, Temps, OctetsPic, NbAllocations, ProfondeurMax };
+
+//!\brief Nombre de métriques enregistrées pour chaque répétition
+constexpr size_t NB_METRIQUES = 5;
+
+//!\brief Durée moyenne minimale, en nanosecondes, d'une série de temps pour être ajustée ou comparée
+constexpr double DUREE_MIN_TEMPS = 10000;
+
+//!\brief Une mesure : la valeur d'une métrique pour un tri, une génération de tableau et un N (indices du balayage)
+struct Mesure {
+    uint16_t algo;
+    uint16_t generateur;
+    Metrique metrique;
+    uint32_t ligne;
+    uint32_t N;
+    double valeur;
+};
+
+//!\brief Ajustement valeur ~ constante * N^exposant d'une série de mesures (en échelle log-log)
+struct Ajustement {
+    uint16_t algo;
+    uint16_t generateur;
+    Metrique metrique;
+    double exposant;
+    double logConstante;
+    double erreurExposant;
+    double ecartResiduel;
+    size_t nbPoints;
+    double moyenneLogN;
+    double sxx;
+    double ecartExecutions;
+};
+
+//!\brief Donne le nom d'une métrique, tel qu'écrit dans les fichiers
+std::string nomMetrique(Metrique metrique);
+
+//!\brief Retrouve une métrique à partir de son nom
+bool metriqueDepuisNom(const std::string& nom, Metrique& metrique);
+
+//!\brief Remplace les temps mesurés plusieurs fois pour une même case par leur médiane
+void regrouperTemps(std::vector<Mesure>& mesures);
+
+//!\brief Ajuste une loi puissance sur chaque série (tri, génération, métrique)
+std::vector<Ajustement> ajusterMesures(const std::vector<Mesure>& mesures);
+
+//!\brief Écrit les ajustements dans un fichier de référence
+void ecrireReference(const std::string& chemin, const std::vector<Ajustement>& ajustements,
+                     const std::vector<std::string>& nomTrie, const std::vector<std::string>& nomGenerateurs);
+
+//!\brief Lit un fichier de référence
+std::vector<Ajustement> lireReference(const std::string& chemin,
+                                      const std::vector<std::string>& nomTrie, const std::vector<std::string>& nomGenerateurs);
+
+//!\brief Compare des mesures à une référence et indique si un ralentissement significatif est détecté
+Verdict verifierReference(const std::vector<Ajustement>& reference, const std::vector<Mesure>& mesures,
+                          const std::vector<std::string>& nomTrie, const std::vector<std::string>& nomGenerateurs,
+                          double tolerance, double toleranceTemps, bool avecTemps, std::ostream& rapport);